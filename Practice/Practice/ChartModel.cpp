@@ -0,0 +1,198 @@
+#include "ChartModel.hpp"
+
+#include <cmath>
+
+namespace detail
+{
+    static constexpr qreal TICK_SPACING_X{ 80. }; // px between labels
+    static constexpr qreal TICK_SPACING_Y{ 40. };
+
+    [[nodiscard]]
+    qreal nice_step(const qreal raw)
+    {
+        const auto magnitude = std::pow(10., std::floor(std::log10(raw)));
+        const auto norm = raw / magnitude;
+
+        return (norm <= 1. ? 1. : norm <= 2. ? 2. : norm <= 5. ? 5. : 10.) * magnitude;
+    }
+
+    void update_ticks(QtCharts::QValueAxis* axis, const qreal pixels, const qreal spacing)
+    {
+        const auto span = axis->max() - axis->min();
+        if (span <= 0. || pixels <= 0.)
+            return;
+
+        const auto step = nice_step(span / std::max(1., std::floor(pixels / spacing)));
+        const auto decimals = std::max(0, static_cast<int>(-std::floor(std::log10(step))));
+
+        axis->setTickAnchor(0.);
+        axis->setTickInterval(step);
+        axis->setLabelFormat(QString("%.%1f").arg(decimals));
+    }
+
+    void set_range(QtCharts::QValueAxis* axis, const ChartModel::range_t& range)
+    {
+        if (range.first > range.second)
+            return;
+
+        if (range.first == range.second) // single value
+            axis->setRange(range.first - .5, range.second + .5);
+        else
+            axis->setRange(range.first, range.second);
+    }
+
+    [[nodiscard]]
+    ChartModel::range_t united(const ChartModel::range_t& a, const ChartModel::range_t& b) noexcept
+    {
+        return { std::min(a.first, b.first), std::max(a.second, b.second) };
+    }
+} // namespace detail
+
+void ChartModel::_fit_x()
+{
+    m_range_x = EMPTY_RANGE;
+    for (auto&& [series, info] : m_series)
+        m_range_x = detail::united(m_range_x, info.range_x);
+
+    detail::set_range(m_axis_x, m_range_x);
+}
+
+void ChartModel::_fit_y(const QString& unit)
+{
+    auto& axis_info = m_axes_y.at(unit);
+
+    axis_info.range = EMPTY_RANGE;
+    for (auto&& [series, info] : m_series)
+        if (info.unit == unit)
+            axis_info.range = detail::united(axis_info.range, info.range_y);
+
+    detail::set_range(axis_info.axis, axis_info.range);
+}
+
+void ChartModel::_update_ticks()
+{
+    const auto plot = m_chart->plotArea();
+
+    detail::update_ticks(m_axis_x, plot.width(), detail::TICK_SPACING_X);
+    for (auto&& [unit, info] : m_axes_y)
+        detail::update_ticks(info.axis, plot.height(), detail::TICK_SPACING_Y);
+
+    emit viewport_changed();
+}
+
+ChartModel::ChartModel(QtCharts::QChart* chart, QObject* parent /* = nullptr */) :
+    QObject(parent),
+    m_chart(chart),
+    m_axis_x(new QtCharts::QValueAxis),
+    m_range_x(EMPTY_RANGE),
+    m_axes_y(),
+    m_series()
+{
+    m_axis_x->setTitleText("t, day");
+    m_axis_x->setTickType(QtCharts::QValueAxis::TicksDynamic);
+    m_chart->addAxis(m_axis_x, Qt::AlignBottom);
+
+    QObject::connect(m_chart, &QtCharts::QChart::plotAreaChanged, this, &ChartModel::_update_ticks);
+    QObject::connect(m_axis_x, &QtCharts::QValueAxis::rangeChanged, this, &ChartModel::_update_ticks);
+}
+
+void ChartModel::add_series(QtCharts::QAbstractSeries* series, const QString& unit, const range_t& range_x, const range_t& range_y)
+{
+    auto it = m_axes_y.find(unit);
+    if (it == m_axes_y.end())
+    {
+        auto axis = new QtCharts::QValueAxis;
+        axis->setTitleText(unit);
+        axis->setTickType(QtCharts::QValueAxis::TicksDynamic);
+        m_chart->addAxis(axis, m_axes_y.size() % 2 ? Qt::AlignRight : Qt::AlignLeft);
+
+        QObject::connect(axis, &QtCharts::QValueAxis::rangeChanged, this, &ChartModel::_update_ticks);
+
+        it = m_axes_y.emplace(unit, axis_info_t{ axis, EMPTY_RANGE, 0 }).first;
+    }
+
+    auto& axis_info = it->second;
+    axis_info.series++;
+
+    series->attachAxis(m_axis_x);
+    series->attachAxis(axis_info.axis);
+
+    m_series[series] = { unit, range_x, range_y };
+
+    m_range_x = detail::united(m_range_x, range_x);
+    axis_info.range = detail::united(axis_info.range, range_y);
+
+    detail::set_range(m_axis_x, m_range_x);
+    detail::set_range(axis_info.axis, axis_info.range);
+}
+
+void ChartModel::remove_series(QtCharts::QAbstractSeries* series)
+{
+    m_chart->removeSeries(series);
+
+    auto it = m_series.find(series);
+    if (it == m_series.end())
+        return;
+
+    const QString unit = it->second.unit;
+    m_series.erase(it);
+
+    emit series_removed(series);
+
+    if (auto& axis_info = m_axes_y.at(unit); !--axis_info.series)
+    {
+        m_chart->removeAxis(axis_info.axis);
+        delete axis_info.axis;
+
+        m_axes_y.erase(unit);
+    }
+    else
+        _fit_y(unit);
+
+    _fit_x();
+}
+
+void ChartModel::clear()
+{
+    m_chart->removeAllSeries();
+    m_series.clear();
+
+    for (auto&& [unit, info] : m_axes_y)
+    {
+        m_chart->removeAxis(info.axis);
+        delete info.axis;
+    }
+    m_axes_y.clear();
+
+    m_range_x = EMPTY_RANGE;
+}
+
+[[nodiscard]]
+QtCharts::QValueAxis* ChartModel::axis_y(const QString& unit) const
+{
+    if (auto it = m_axes_y.find(unit); it != m_axes_y.end())
+        return it->second.axis;
+
+    return nullptr;
+}
+
+[[nodiscard]]
+QVariantMap ChartModel::viewport() const
+{
+    QVariantMap res;
+    res["x"] = QPointF(m_axis_x->min(), m_axis_x->max());
+    for (auto&& [unit, info] : m_axes_y)
+        res["y:" + unit] = QPointF(info.axis->min(), info.axis->max());
+
+    return res;
+}
+
+void ChartModel::set_viewport(const QVariantMap& viewport)
+{
+    if (auto it = viewport.find("x"); it != viewport.end())
+        m_axis_x->setRange(it->toPointF().x(), it->toPointF().y());
+
+    for (auto&& [unit, info] : m_axes_y)
+        if (auto it = viewport.find("y:" + unit); it != viewport.end())
+            info.axis->setRange(it->toPointF().x(), it->toPointF().y());
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QtCharts/QChart>
+#include <QtCharts/QValueAxis>
+#include <QVariantMap>
+
+#include <map>
+#include <limits>
+#include <algorithm>
+
+// Owns the axes of the chart: one shared X axis and a Y axis per unit (param).
+// Ranges are kept as the union of per-series bounds, so adding a series is O(1)
+// and removing one is O(series). Tick density follows the visible span and the plot size.
+class ChartModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    using range_t = std::pair<qreal, qreal>; // min, max
+
+    static constexpr range_t EMPTY_RANGE{ std::numeric_limits<qreal>::max(), std::numeric_limits<qreal>::lowest() };
+
+    static inline void extend(range_t& range, const qreal val) noexcept { range = { std::min(range.first, val), std::max(range.second, val) }; }
+
+private:
+    struct series_info_t
+    {
+        QString unit;
+        range_t range_x;
+        range_t range_y;
+    };
+
+    struct axis_info_t
+    {
+        QtCharts::QValueAxis *axis;
+        range_t               range;
+        size_t                series;
+    };
+
+    void _fit_x();
+    void _fit_y(const QString& unit);
+
+signals:
+    void viewport_changed();
+    void series_removed(QtCharts::QAbstractSeries* series); // before its axis may be deleted
+
+private slots:
+    void _update_ticks();
+
+public:
+    ChartModel(QtCharts::QChart* chart, QObject* parent = nullptr);
+
+    void add_series(QtCharts::QAbstractSeries* series, const QString& unit, const range_t& range_x, const range_t& range_y);
+    void remove_series(QtCharts::QAbstractSeries* series);
+    void clear();
+
+    [[nodiscard]] inline QtCharts::QValueAxis* axis_x() const noexcept { return m_axis_x; }
+
+    [[nodiscard]]
+    QtCharts::QValueAxis* axis_y(const QString& unit) const;
+
+    [[nodiscard]]
+    QVariantMap viewport() const;
+    void set_viewport(const QVariantMap& viewport);
+
+private:
+    QtCharts::QChart                                    *m_chart;
+    QtCharts::QValueAxis                                *m_axis_x;
+    range_t                                              m_range_x;
+    std::map<QString, axis_info_t>                       m_axes_y;
+    std::map<QtCharts::QAbstractSeries*, series_info_t>  m_series;
+};
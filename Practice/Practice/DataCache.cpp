@@ -0,0 +1,229 @@
+#include "DataCache.hpp"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+namespace detail
+{
+    // Every non-empty QString is a separate allocation: QArrayData header, characters and terminator
+    static constexpr size_t STRING_OVERHEAD{ sizeof(QArrayData) + sizeof(QChar) };
+
+    [[nodiscard]]
+    size_t bytes_of(const QStringList& list)
+    {
+        return std::accumulate(list.begin(), list.end(), static_cast<size_t>(list.size()) * sizeof(QString),
+            [](const size_t sum, const QString& str) { return sum + (str.isEmpty() ? 0 : STRING_OVERHEAD + str.size() * sizeof(QChar)); });
+    }
+} // namespace detail
+
+[[nodiscard]]
+QString DataCache::_spill_path(const source_t& source, const size_t idx) const
+{
+    return m_spill_dir.filePath(QString("%1_%2.bin").arg(source.id).arg(idx));
+}
+
+void DataCache::_spill(source_t& source, const size_t idx)
+{
+    auto& column = source.columns[idx];
+    if (!column.on_disk)
+    {
+        QFile file(_spill_path(source, idx));
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+
+        QDataStream stream(&file);
+        stream << column.data;
+
+        column.on_disk = stream.status() == QDataStream::Ok;
+        if (!column.on_disk)
+            return;
+    }
+
+    column.data.clear();
+    column.resident = false;
+    m_resident -= column.bytes;
+    m_stats.spills++;
+}
+
+[[nodiscard]]
+bool DataCache::_reload(source_t& source, const size_t idx)
+{
+    auto& column = source.columns[idx];
+
+    QFile file(_spill_path(source, idx));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream >> column.data;
+    if (stream.status() != QDataStream::Ok)
+    {
+        column.data.clear();
+
+        return false;
+    }
+
+    column.resident = true;
+    m_resident += column.bytes;
+
+    return true;
+}
+
+void DataCache::_remove_files(const source_t& source)
+{
+    for (size_t i{}; i < source.columns.size(); ++i)
+        if (source.columns[i].on_disk)
+            QFile::remove(_spill_path(source, i));
+}
+
+void DataCache::_enforce_budget(const column_t* keep /* = nullptr */)
+{
+    while (m_resident > m_budget)
+    {
+        source_t* coldest_source{};
+        size_t coldest_idx{};
+        size_t coldest_use{ std::numeric_limits<size_t>::max() };
+        for (auto&& [uName, source] : m_sources)
+            for (size_t i{}; i < source.columns.size(); ++i)
+                if (auto& column = source.columns[i]; column.resident && &column != keep && column.last_use < coldest_use)
+                {
+                    coldest_source = &source;
+                    coldest_idx = i;
+                    coldest_use = column.last_use;
+                }
+
+        if (!coldest_source)
+            break;
+
+        const auto before = m_resident;
+        _spill(*coldest_source, coldest_idx);
+        if (m_resident == before) // failed to write, keep the rest in memory
+            break;
+    }
+}
+
+DataCache::DataCache(const size_t budget /* = DEFAULT_BUDGET */) :
+    m_sources(),
+    m_spill_dir(),
+    m_budget(budget),
+    m_resident(),
+    m_clock(),
+    m_next_id(),
+    m_stats()
+{ }
+
+DataCache::~DataCache() noexcept
+{
+    for (auto&& [uName, source] : m_sources)
+        _remove_files(source);
+}
+
+void DataCache::insert(const QString& uName, std::vector<QStringList>&& data)
+{
+    if (auto it = m_sources.find(uName); it != m_sources.end())
+    {
+        m_resident -= detail::bytes_of(it->second.names);
+        for (auto& column : it->second.columns)
+            if (column.resident)
+                m_resident -= column.bytes;
+
+        _remove_files(it->second);
+        m_sources.erase(it);
+    }
+
+    if (data.empty())
+        return;
+
+    source_t source{ m_next_id++, std::move(data[0]), {} };
+    m_resident += detail::bytes_of(source.names); // never spilled, but still counted against the budget
+
+    source.columns.reserve(data.size() - 1);
+    for (size_t i{ 1 }; i < data.size(); ++i)
+    {
+        const auto bytes = detail::bytes_of(data[i]);
+
+        source.columns.push_back({ std::move(data[i]), bytes, ++m_clock, true, false });
+        m_resident += bytes;
+    }
+
+    m_sources.emplace(uName, std::move(source));
+
+    _enforce_budget();
+}
+
+[[nodiscard]]
+std::optional<QStringList> DataCache::column(const QString& uName, const size_t idx)
+{
+    auto it = m_sources.find(uName);
+    if (it == m_sources.end())
+        return std::nullopt;
+
+    auto& source = it->second;
+    if (!idx)
+        return source.names;
+
+    if (idx > source.columns.size())
+        return std::nullopt;
+
+    auto& column = source.columns[idx - 1];
+    column.last_use = ++m_clock;
+    if (column.resident)
+        m_stats.hits++;
+    else
+    {
+        m_stats.misses++;
+
+        if (!_reload(source, idx - 1))
+            return std::nullopt;
+
+        _enforce_budget(&column);
+    }
+
+    return column.data;
+}
+
+[[nodiscard]]
+QStringList DataCache::params(const QString& uName) const
+{
+    if (auto it = m_sources.find(uName); it != m_sources.end())
+        return it->second.names;
+
+    return {};
+}
+
+[[nodiscard]]
+size_t DataCache::source_bytes(const QString& uName) const
+{
+    auto it = m_sources.find(uName);
+    if (it == m_sources.end())
+        return 0;
+
+    size_t res{ detail::bytes_of(it->second.names) };
+    for (const auto& column : it->second.columns)
+        if (column.resident)
+            res += column.bytes;
+
+    return res;
+}
+
+[[nodiscard]]
+std::vector<QString> DataCache::sources() const
+{
+    std::vector<QString> res;
+    res.reserve(m_sources.size());
+    for (auto&& [uName, source] : m_sources)
+        res.push_back(uName);
+
+    return res;
+}
+
+void DataCache::set_budget(const size_t budget)
+{
+    m_budget = budget;
+
+    _enforce_budget();
+}
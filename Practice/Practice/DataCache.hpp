@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <vector>
+#include <map>
+#include <optional>
+
+// Holds parsed sources under a memory budget. Layout of every source is the same as before:
+// [params_names, dates, values...]. Names are always resident, other columns are
+// spilled to disk in LRU order and reloaded on access. Sizes are estimated from the
+// QString layout, allocator padding is not counted.
+class DataCache
+{
+public:
+    static constexpr size_t DEFAULT_BUDGET{ 256LLU * 1024 * 1024 };
+
+    struct stats_t
+    {
+        size_t hits;
+        size_t misses;
+        size_t spills;
+    };
+
+private:
+    struct column_t
+    {
+        QStringList data;
+        size_t      bytes;
+        size_t      last_use;
+        bool        resident;
+        bool        on_disk;
+    };
+
+    struct source_t
+    {
+        size_t                id;
+        QStringList           names;
+        std::vector<column_t> columns; // dates, values...
+    };
+
+    [[nodiscard]]
+    QString _spill_path(const source_t& source, const size_t idx) const;
+
+    void _spill(source_t& source, const size_t idx);
+
+    [[nodiscard]]
+    bool _reload(source_t& source, const size_t idx);
+
+    void _remove_files(const source_t& source);
+
+    void _enforce_budget(const column_t* keep = nullptr);
+
+public:
+    explicit DataCache(const size_t budget = DEFAULT_BUDGET);
+    ~DataCache() noexcept;
+
+    void insert(const QString& uName, std::vector<QStringList>&& data);
+
+    // std::nullopt if there is no such column or it failed to reload from disk
+    [[nodiscard]]
+    std::optional<QStringList> column(const QString& uName, const size_t idx);
+
+    [[nodiscard]]
+    QStringList params(const QString& uName) const;
+
+    [[nodiscard]]
+    size_t source_bytes(const QString& uName) const;
+
+    [[nodiscard]]
+    std::vector<QString> sources() const;
+
+    [[nodiscard]] inline bool contains(const QString& uName) const { return m_sources.find(uName) != m_sources.end(); }
+    [[nodiscard]] inline bool empty() const noexcept { return m_sources.empty(); }
+
+    [[nodiscard]] inline size_t resident_bytes() const noexcept { return m_resident; }
+    [[nodiscard]] inline size_t budget() const noexcept { return m_budget; }
+    [[nodiscard]] inline const stats_t& stats() const noexcept { return m_stats; }
+
+    void set_budget(const size_t budget);
+
+private:
+    std::map<QString, source_t>  m_sources;
+    QTemporaryDir                m_spill_dir;
+    size_t                       m_budget;
+    size_t                       m_resident;
+    size_t                       m_clock;
+    size_t                       m_next_id;
+    stats_t                      m_stats;
+};
@@ -3,8 +3,20 @@
 #include <QtCharts/QValueAxis>
 #include <QNetworkReply>
 #include <QMessageBox.h>
+#include <QInputDialog>
+#include <QSettings>
+#include <QDir>
+#include <QCloseEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QCryptographicHash>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <algorithm>
+#include <iterator>
+#include <functional>
 
 #include "DownloadDialog.hpp"
 
@@ -12,15 +24,6 @@ namespace detail
 {
     static constexpr auto DATE_FMT{ "yyyy-MM-dd hh:mm:ss" };
 
-    typedef QtCharts::QAbstractAxis* (QtCharts::QChart::*axis_func_t)(QtCharts::QAbstractSeries*)const;
-
-    void set_range(const qreal val, QtCharts::QChart* chart, axis_func_t axis)
-    {
-        auto min = std::min(val, dynamic_cast<QtCharts::QValueAxis*>((chart->*axis)(nullptr))->min());
-        auto max = std::max(val, dynamic_cast<QtCharts::QValueAxis*>((chart->*axis)(nullptr))->max());
-        (chart->*axis)(nullptr)->setRange(min, max);
-    }
-
     auto as_is(const QStringList& dates, const QStringList& values)
     {
         static constexpr auto MINUTES_PER_DAY{ 1440. };
@@ -247,148 +250,361 @@ namespace detail
 
         return res;
     }
-} // namespace detail
 
-void Practice::_csv2chart(const QString& csvstr)
-{
-    _add_log_msg("Parsing csv");
+    // Indexed by combo_avg
+    static constexpr decltype(&as_is) CONVERTERS[]
+    {
+        &as_is,
+        &average_hour,
+        &average_3hour,
+        &average_day,
+        &min_day,
+        &max_day,
+    };
 
-    m_ui->label_status->setText("Parsing csv");
+    [[nodiscard]]
+    constexpr bool is_converter(const int avg_idx) noexcept { return avg_idx >= 0 && avg_idx < static_cast<int>(std::size(CONVERTERS)); }
 
-    QString uName = m_ui->combo_source->currentText();
-    if (m_data.find(uName) != m_data.end())
-        m_data[uName].clear();
+    using progress_func_t = std::function<void(const int)>; // percent
 
-    auto lines = csvstr.split("\n");
+    [[nodiscard]]
+    Practice::source_t parse_csv(const QString& uName, const QString& csvstr, const progress_func_t& progress = {})
+    {
+        auto lines = csvstr.split("\n");
+        if (lines.size() < 2)
+            return { uName, {} };
 
-    m_data[uName].push_back(lines[1].split(";"));
-    m_data[uName][0].removeFirst();
+        std::vector<QStringList> data;
+        data.push_back(lines[1].split(";"));
+        data[0].removeFirst();
 
-    _update_combo_params(uName);
+        data.resize(data[0].size() + 2); // for DateTime and names
+        for (size_t i{ 2 }; i < lines.size(); ++i)
+        {
+            auto values = lines[i].split(";");
+            for (size_t j{}; j < values.size() && j + 1 < data.size(); ++j)
+                data[j + 1].push_back(values[j]);
 
-    m_data[uName].resize(m_data[uName][0].size() + 2); // for DateTime and names
-    for (size_t i{ 2 }; i < lines.size(); ++i)
-    {
-        auto values = lines[i].split(";");
-        for (size_t j{}; j < values.size(); ++j)
-            m_data[uName][j + 1].push_back(values[j]);
+            if (progress)
+                progress((i + 1LLU) * 100 / lines.size());
+        }
+
+        return { uName, std::move(data) };
     }
 
-    m_ui->label_status->setText("OK");
-}
+    [[nodiscard]]
+    Practice::source_t parse_json(const QString& jsonstr, const progress_func_t& progress = {})
+    {
+        QJsonDocument json_doc = QJsonDocument::fromJson(jsonstr.toUtf8());
+        QJsonObject json = json_doc.object();
 
-void Practice::_json2chart(const QString& jsonstr)
-{
-    _add_log_msg("Parsing json");
+        const auto json_keys = json.keys();
+        size_t done{};
 
-    m_ui->label_status->setText("Parsing json");
+        QString title;
+        std::vector<QStringList> data_columns;
+        bool first = true;
+        for (const auto& i : json_keys)
+        {
+            if (progress)
+                progress((1LLU + done++) * 100 / json_keys.size());
 
-    QJsonDocument json_doc = QJsonDocument::fromJson(jsonstr.toUtf8());
-    QJsonObject json = json_doc.object();
+            QJsonValue value = json.value(QString(i));
+            QJsonObject item = value.toObject();
 
-    size_t progress{};
-    m_ui->progress_bar->setValue(0);
+            QString uName = item.value(QString("uName")).toString().toUtf8();
 
-    QString title;
-    bool first = true;
-    for (const auto& i : json.keys())
-    {
-        QJsonValue value = json.value(QString(i));
-        QJsonObject item = value.toObject();
+            if (title.isEmpty())
+                title = uName;
 
-        QString uName = item.value(QString("uName")).toString().toUtf8();
+            if (uName == title)
+            {
+                QJsonObject data = item.value(QString("data")).toObject();
 
-        if (title.isEmpty())
-            title = uName;
+                auto keys = data.keys();
 
-        if (uName == title)
-        {
-            QJsonObject data = item.value(QString("data")).toObject();
+                if (first)
+                {
+                    // keys.erase(std::remove_if(keys.begin(), keys.end(), [](const auto& s) { return s.startsWith("system"); }), keys.end());
 
-            auto keys = data.keys();
-            
-            if (first)
-            {
-                _update_combo_source(uName);
-                m_data[uName].clear();
+                    data_columns.resize(data.keys().size() + 2); // +1 date; +1 names
 
-                // keys.erase(std::remove_if(keys.begin(), keys.end(), [](const auto& s) { return s.startsWith("system"); }), keys.end());
+                    data_columns[0] = keys;
 
-                m_data[uName].resize(data.keys().size() + 2); // +1 date; +1 names
+                    first = false;
+                }
 
-                m_data[uName][0] = keys;
-                _update_combo_params(uName);
+                data_columns[1].append(item.value(QString("Date")).toString());
 
-                first = false;
+                size_t idx{ 2 }; // pass DateTime and names
+                for (const auto& param_name : keys)
+                    data_columns[idx++].append(data.value(QString(param_name)).toString());
             }
-            
-            m_data[uName][1].append(item.value(QString("Date")).toString());
+        }
 
-            size_t idx{ 2 }; // pass DateTime and names
-            for (const auto& param_name : keys)
-                m_data[uName][idx++].append(data.value(QString(param_name)).toString());
+        return { title, std::move(data_columns) };
+    }
+
+    [[nodiscard]]
+    Practice::source_t parse_source(const QString& filepath, const QString& content, const progress_func_t& progress = {})
+    {
+        if (filepath.endsWith("csv"))
+            return parse_csv(QFileInfo(filepath).fileName().section(".", 0, 0), content, progress);
 
-            m_ui->progress_bar->setValue((1. + progress++) / json.keys().size() * 100);
+        return parse_json(content, progress);
+    }
+
+    // Runs on a worker thread, so must not touch the ui. Requested (param, avg_idx) columns
+    // are converted here while the data is at hand, date parsing is too slow for the gui thread
+    [[nodiscard]]
+    Practice::loaded_t load_source(const QString& filepath, const std::vector<std::pair<QString, int>>& requests)
+    {
+        QFile file(filepath);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return {};
+
+        Practice::loaded_t res{ parse_source(filepath, file.readAll()), {} };
+
+        const auto& data = res.first.second;
+        if (data.size() < 2)
+            return res;
+
+        for (auto&& [param, avg_idx] : requests)
+        {
+            const auto val_idx = data[0].indexOf(param);
+            if (val_idx < 0 || static_cast<size_t>(val_idx) + 2 >= data.size() || !is_converter(avg_idx) || res.second.count({ param, avg_idx }))
+                continue;
+
+            const auto& values = data[val_idx + 2];
+            if (data[1].size() >= values.size())
+                res.second.emplace(std::make_pair(param, avg_idx), CONVERTERS[avg_idx](data[1], values));
         }
+
+        return res;
     }
+} // namespace detail
 
-    m_ui->label_status->setText("OK");
+void Practice::_add_source(source_t&& source, const QString& filepath, const bool select /* = true */)
+{
+    auto&& [uName, data] = source;
+    if (uName.isEmpty() || data.empty())
+    {
+        _show_warning("Failed to parse data");
+
+        return;
+    }
+
+    m_cache.insert(uName, std::move(data));
+    if (!filepath.isEmpty())
+        m_sources[uName] = filepath;
+
+    if (select)
+        _update_combo_source(uName);
+    else if (m_ui->combo_source->findText(uName) < 0)
+        m_ui->combo_source->addItem(uName);
+
+    if (m_ui->combo_source->currentText() == uName)
+        _update_combo_params(uName);
+
+    _log_memory_usage(uName);
+}
+
+void Practice::_load_source_async(const QString& uName)
+{
+    if (m_cache.contains(uName) || m_loading.count(uName) || !m_sources.count(uName))
+        return;
+
+    _add_log_msg("Loading " + uName);
+
+    m_loading.insert(uName);
+
+    std::vector<std::pair<QString, int>> requests;
+    for (const auto& series : m_pending_series)
+        if (series.uName == uName)
+            requests.emplace_back(series.param, series.avg_idx);
+
+    const QString filepath = m_sources.at(uName);
+    auto watcher = new QFutureWatcher<loaded_t>(this);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, [this, watcher, uName, filepath]()
+        {
+            m_loading.erase(uName);
+
+            auto [source, converted] = watcher->result();
+            watcher->deleteLater();
+
+            source.first = uName;
+            if (source.second.empty())
+                _show_warning("Failed to load " + uName.toStdString());
+            else
+                _add_source(std::move(source), filepath, false);
+
+            _draw_pending(uName, converted);
+        });
+
+    watcher->setFuture(QtConcurrent::run(&detail::load_source, filepath, requests));
+}
+
+void Practice::_draw_pending(const QString& uName, const converted_t& converted /* = {} */)
+{
+    for (auto it = m_placeholders.begin(); it != m_placeholders.end();)
+        if (it->first == uName)
+        {
+            m_chart_model->remove_series(it->second);
+            delete it->second;
+
+            it = m_placeholders.erase(it);
+        }
+        else
+            ++it;
+
+    // Taken out first, drawing may show a warning and let another source finish meanwhile
+    std::vector<series_t> ready;
+    auto it = std::stable_partition(m_pending_series.begin(), m_pending_series.end(), [&uName](const auto& series) { return series.uName != uName; });
+    std::move(it, m_pending_series.end(), std::back_inserter(ready));
+    m_pending_series.erase(it, m_pending_series.end());
+
+    if (m_cache.contains(uName))
+        for (const auto& series : ready)
+            if (auto conv = converted.find({ series.param, series.avg_idx }); conv != converted.end())
+                _add_series(series, conv->second);
+            else
+                _add_series(series);
+
+    if (!m_pending_series.empty())
+        return;
+
+    if (m_pending_viewport && !m_series.empty())
+        m_chart_model->set_viewport(*m_pending_viewport);
+
+    m_pending_viewport.reset();
+    m_chart->setTitle("");
 }
 
 [[nodiscard]]
-auto Practice::_get_converted(const size_t val_idx) const
+auto Practice::_get_converted(const QString& uName, const size_t val_idx, const int avg_idx) const
 {
     _add_log_msg("Applying convesations");
 
+    if (!detail::is_converter(avg_idx))
+    {
+        _show_warning("No such averaging");
+
+        return std::vector<std::pair<qreal, qreal>>{};
+    }
+
     m_ui->label_status->setText("Calculating");
 
-    using func_t = std::function<decltype(detail::as_is)>;
-    static func_t funcs[]
+    auto dates = m_cache.column(uName, 1);
+    auto values = m_cache.column(uName, val_idx + 2);
+    if (!dates || !values || dates->size() < values->size())
     {
-        &detail::as_is,
-        &detail::average_hour,
-        &detail::average_3hour,
-        &detail::average_day,
-        &detail::min_day,
-        &detail::max_day,
-    };
+        _show_warning("Failed to reload data");
 
-    m_chart->axisX()->setTitleText("t, day");
+        return std::vector<std::pair<qreal, qreal>>{};
+    }
 
-    QString uName = m_ui->combo_source->currentText();
-    auto res = funcs[m_ui->combo_avg->currentIndex()](m_data.at(uName)[1], m_data.at(uName)[val_idx + 2]);
+    auto res = detail::CONVERTERS[avg_idx](*dates, *values);
 
     m_ui->label_status->setText("OK");
 
     return res;
 }
 
-void Practice::_draw(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values) const
+void Practice::_draw(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values, const int graph_type) const
 {
-    if (auto idx = m_ui->combo_graph_type->currentIndex(); !idx)
+    if (!graph_type)
         _draw_series<QtCharts::QLineSeries>(param_name, values);
-    else if (idx == 1)
-        _draw_series<QtCharts::QBarSeries>(param_name, values);
+    else if (graph_type == 1)
+        _draw_raster(param_name, values, RasterLayer::kind_t::BARS);
     else
-        _draw_series<QtCharts::QScatterSeries>(param_name, values);
+        _draw_raster(param_name, values, RasterLayer::kind_t::SCATTER);
+}
+
+void Practice::_draw_raster(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values, const RasterLayer::kind_t kind) const
+{
+    _add_log_msg("Drawing");
+
+    m_ui->label_status->setText("Preparing data for drawing");
+
+    auto points = std::make_shared<RasterLayer::points_t>();
+    points->reserve(values.size());
+
+    auto range_x = ChartModel::EMPTY_RANGE;
+    auto range_y = ChartModel::EMPTY_RANGE;
+    for (auto&& [x, y] : values)
+    {
+        points->push_back({ x, y });
+
+        ChartModel::extend(range_x, x);
+        ChartModel::extend(range_y, y);
+    }
+
+    if (kind == RasterLayer::kind_t::BARS)
+    {
+        // columns grow from zero and stick out by half of their width
+        const auto half_width = RasterLayer::bar_width(*points) / 2.;
+
+        ChartModel::extend(range_x, range_x.first - half_width);
+        ChartModel::extend(range_x, range_x.second + half_width);
+        ChartModel::extend(range_y, 0.);
+    }
+
+    // Empty series for the legend and axes, the points are drawn by the raster layer
+    auto proxy = new QtCharts::QScatterSeries;
+    proxy->setName(param_name);
+    proxy->setMarkerShape(kind == RasterLayer::kind_t::BARS ? QtCharts::QScatterSeries::MarkerShapeRectangle : QtCharts::QScatterSeries::MarkerShapeCircle);
+
+    m_chart->addSeries(proxy);
+    m_chart_model->add_series(proxy, param_name, range_x, range_y);
+    m_raster->add_series(proxy, m_chart_model->axis_y(param_name), kind, std::move(points));
+
+    m_ui->progress_bar->setValue(100);
+    m_ui->label_status->setText("OK");
+}
+
+void Practice::_add_series(const series_t& series)
+{
+    auto val_idx = m_cache.params(series.uName).indexOf(series.param);
+    if (val_idx < 0)
+    {
+        _show_warning("No such param");
+
+        return;
+    }
+
+    _add_series(series, _get_converted(series.uName, val_idx, series.avg_idx));
+}
+
+void Practice::_add_series(const series_t& series, const std::vector<std::pair<qreal, qreal>>& values)
+{
+    if (values.empty())
+        return;
+
+    _draw(series.param, values, series.graph_type);
+
+    m_series.push_back(series);
+
+    _show_memory_usage(); // columns may have been reloaded or spilled
 }
 
 void Practice::_update()
 {
-    if (m_data.empty())
+    QString uName = m_ui->combo_source->currentText();
+    if (m_loading.count(uName))
     {
-        _show_warning("No data");
+        _show_warning("Data is still loading");
 
         return;
     }
 
-    size_t val_idx = m_ui->combo_params->currentIndex();
-    QString param_name = m_data[m_ui->combo_source->currentText()][0][val_idx];
-    m_chart->axisY()->setTitleText(param_name);
+    if (!m_cache.contains(uName))
+    {
+        _show_warning("No data");
 
-    auto res = _get_converted(val_idx);
-    
-    _draw(param_name, res);
+        return;
+    }
+
+    _add_series({ uName, m_ui->combo_params->currentText(), m_ui->combo_avg->currentIndex(), m_ui->combo_graph_type->currentIndex() });
 }
 
 void Practice::_show_warning(const std::string_view msg) const
@@ -424,14 +640,22 @@ void Practice::_update_combo_params(const QString& uName)
     _add_log_msg("Updating params");
 
     m_ui->combo_params->clear();
-    m_ui->combo_params->addItems(m_data[uName][0]);
+    m_ui->combo_params->addItems(m_cache.params(uName));
+
+    if (!m_pending_param.isEmpty())
+    {
+        m_ui->combo_params->setCurrentText(m_pending_param);
+        m_pending_param.clear();
+    }
 }
 
 void Practice::_update_combo_source(const QString& uName)
 {
     _add_log_msg("Updating sources");
 
-    m_ui->combo_source->addItem(uName);
+    if (m_ui->combo_source->findText(uName) < 0)
+        m_ui->combo_source->addItem(uName);
+
     m_ui->combo_source->setCurrentText(uName);
 }
 
@@ -439,11 +663,170 @@ void Practice::_setup_chart()
 {
     _add_log_msg("Setting up chart");
 
-    m_chart->addAxis(new QtCharts::QValueAxis, Qt::AlignBottom);
-    m_chart->addAxis(new QtCharts::QValueAxis, Qt::AlignLeft);
+    m_chart_model = new ChartModel(m_chart, this);
+    m_raster = new RasterLayer(m_chart, m_chart_model);
 
     m_ui->graphic->setChart(m_chart);
     m_ui->graphic->setRenderHint(QPainter::Antialiasing);
+
+    // Drag to pan, wheel to zoom
+    m_ui->graphic->viewport()->installEventFilter(this);
+}
+
+[[nodiscard]]
+QString Practice::_memory_usage(const QString& uName) const
+{
+    static constexpr auto KIB{ 1024. };
+
+    return QString("%1 %2 KiB, total %3 / %4 KiB")
+        .arg(uName)
+        .arg(m_cache.source_bytes(uName) / KIB, 0, 'f', 1)
+        .arg(m_cache.resident_bytes() / KIB, 0, 'f', 1)
+        .arg(m_cache.budget() / KIB, 0, 'f', 1);
+}
+
+void Practice::_log_memory_usage(const QString& uName) const
+{
+    _add_log_msg("Memory: " + _memory_usage(uName));
+
+    _show_memory_usage();
+}
+
+void Practice::_show_memory_usage() const
+{
+    if (QString uName = m_ui->combo_source->currentText(); m_cache.contains(uName))
+        m_ui->label_status->setText("OK, " + _memory_usage(uName));
+}
+
+void Practice::_on_clear()
+{
+    m_raster->clear();
+    m_chart_model->clear();
+    m_chart->setTitle("");
+
+    m_series.clear();
+    m_pending_series.clear();
+    m_placeholders.clear(); // already deleted by the chart
+    m_pending_viewport.reset();
+}
+
+void Practice::_save_session() const
+{
+    _add_log_msg("Saving session");
+
+    QSettings settings;
+    settings.remove("session");
+    settings.beginGroup("session");
+
+    settings.beginWriteArray("sources");
+    int i{};
+    for (auto&& [uName, filepath] : m_sources)
+    {
+        settings.setArrayIndex(i++);
+        settings.setValue("uName", uName);
+        settings.setValue("path", filepath);
+    }
+    settings.endArray();
+
+    // Series that are not restored yet are kept as well
+    std::vector<series_t> all_series(m_series);
+    all_series.insert(all_series.end(), m_pending_series.begin(), m_pending_series.end());
+
+    settings.beginWriteArray("series");
+    i = 0;
+    for (const auto& series : all_series)
+    {
+        settings.setArrayIndex(i++);
+        settings.setValue("uName", series.uName);
+        settings.setValue("param", series.param);
+        settings.setValue("avg", series.avg_idx);
+        settings.setValue("graph_type", series.graph_type);
+    }
+    settings.endArray();
+
+    settings.setValue("source", m_ui->combo_source->currentText());
+    settings.setValue("param", m_ui->combo_params->currentText());
+    settings.setValue("avg", m_ui->combo_avg->currentIndex());
+    settings.setValue("graph_type", m_ui->combo_graph_type->currentIndex());
+
+    if (m_pending_viewport)
+        settings.setValue("viewport", *m_pending_viewport);
+    else if (!m_series.empty())
+        settings.setValue("viewport", m_chart_model->viewport());
+
+    settings.endGroup();
+}
+
+// Only reads the settings and creates placeholders, the data itself is loaded after the first frame
+void Practice::_restore_session()
+{
+    QSettings settings;
+    settings.beginGroup("session");
+
+    int size = settings.beginReadArray("sources");
+    for (int i{}; i < size; ++i)
+    {
+        settings.setArrayIndex(i);
+
+        QString uName = settings.value("uName").toString();
+        QString filepath = settings.value("path").toString();
+        if (uName.isEmpty() || !QFileInfo::exists(filepath))
+            continue;
+
+        m_sources[uName] = filepath;
+        m_ui->combo_source->addItem(uName);
+    }
+    settings.endArray();
+
+    size = settings.beginReadArray("series");
+    for (int i{}; i < size; ++i)
+    {
+        settings.setArrayIndex(i);
+
+        series_t series{ settings.value("uName").toString(), settings.value("param").toString(), settings.value("avg").toInt(), settings.value("graph_type").toInt() };
+        // Written by an older or edited config, drawing it would index past the converters
+        if (!m_sources.count(series.uName) || !detail::is_converter(series.avg_idx) || series.graph_type < 0 || series.graph_type >= m_ui->combo_graph_type->count())
+            continue;
+
+        auto placeholder = new QtCharts::QLineSeries;
+        placeholder->setName(series.param + " (loading)");
+        m_chart->addSeries(placeholder);
+
+        m_placeholders.emplace_back(series.uName, placeholder);
+        m_pending_series.push_back(std::move(series));
+    }
+    settings.endArray();
+
+    m_ui->combo_source->setCurrentText(settings.value("source").toString());
+    if (const auto avg_idx = settings.value("avg", 0).toInt(); detail::is_converter(avg_idx) && avg_idx < m_ui->combo_avg->count())
+        m_ui->combo_avg->setCurrentIndex(avg_idx);
+
+    if (const auto graph_type = settings.value("graph_type", 0).toInt(); graph_type >= 0 && graph_type < m_ui->combo_graph_type->count())
+        m_ui->combo_graph_type->setCurrentIndex(graph_type);
+    m_pending_param = settings.value("param").toString();
+
+    if (!m_pending_series.empty())
+    {
+        if (settings.contains("viewport"))
+            m_pending_viewport = settings.value("viewport").toMap();
+
+        m_chart->setTitle("Loading session...");
+    }
+
+    settings.endGroup();
+
+    _add_log_msg(QString("Session: %1 sources, %2 series").arg(m_sources.size()).arg(m_pending_series.size()));
+}
+
+void Practice::_on_first_frame()
+{
+    _add_log_msg(QString("First frame in %1 ms").arg(m_startup_timer.elapsed()));
+
+    // Only the sources whose series are on the chart, and the selected one
+    for (const auto& series : m_pending_series)
+        _load_source_async(series.uName);
+
+    _load_source_async(m_ui->combo_source->currentText());
 }
 
 void Practice::_on_net_result(QNetworkReply* reply)
@@ -461,7 +844,18 @@ void Practice::_on_net_result(QNetworkReply* reply)
 
         m_ui->progress_bar->setValue(50);
 
-        _json2chart(content);
+        _add_log_msg("Parsing json");
+
+        auto source = detail::parse_json(content, [this](const int percent) { m_ui->progress_bar->setValue(50 + percent / 2); });
+
+        // Keep a copy so the session can be restored without downloading again
+        QString dirpath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/sources";
+        // uName comes from the server, so it is hashed instead of being used as a file name
+        QString filepath = dirpath + "/" + QString::fromLatin1(QCryptographicHash::hash(source.first.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".json";
+        if (QFile file(filepath); source.first.isEmpty() || !QDir().mkpath(dirpath) || !file.open(QIODevice::WriteOnly | QIODevice::Text) || file.write(content.toUtf8()) < 0)
+            filepath.clear();
+
+        _add_source(std::move(source), filepath);
 
         m_ui->progress_bar->setValue(100);
     }
@@ -493,16 +887,17 @@ void Practice::_on_action_open_data()
     file.close();
 
     _update_pte_data(content);
-    
-    QString uName = QFileInfo(filepath).fileName().section(".", 0, 0);
-    
-    if (filepath.endsWith("csv"))
-    {
-        _update_combo_source(uName);
-        _csv2chart(content);
-    }
-    else
-        _json2chart(content);
+
+    _add_log_msg("Parsing data");
+
+    m_ui->label_status->setText("Parsing data");
+
+    m_ui->progress_bar->setValue(0);
+
+    _add_source(detail::parse_source(filepath, content, [this](const int percent) { m_ui->progress_bar->setValue(percent); }), filepath);
+
+    m_ui->label_status->setText("OK");
+    _show_memory_usage();
 }
 
 void Practice::_on_action_download_data()
@@ -537,13 +932,54 @@ void Practice::_on_action_download_data()
     m_net_manager->get(req);
 }
 
+void Practice::_on_action_memory_budget()
+{
+    static constexpr size_t MIB{ 1024LLU * 1024 };
+
+    bool ok{};
+    int budget = QInputDialog::getInt(this, tr("Memory budget"), tr("Budget, MiB:"), static_cast<int>(m_cache.budget() / MIB), 1, 64 * 1024, 1, &ok);
+    if (!ok)
+    {
+        _add_log_msg("Canceled");
+
+        return;
+    }
+
+    m_cache.set_budget(budget * MIB);
+
+    _on_action_memory_stats();
+}
+
+void Practice::_on_action_memory_stats()
+{
+    for (const auto& uName : m_cache.sources())
+        _log_memory_usage(uName);
+
+    auto&& [hits, misses, spills] = m_cache.stats();
+    _add_log_msg(QString("Cache: %1 hits, %2 misses, %3 spills").arg(hits).arg(misses).arg(spills));
+}
+
 Practice::Practice(QWidget* parent /* = nullptr */) :
     QMainWindow(parent),
     m_ui(new Ui::PracticeClass),
     m_chart(new QtCharts::QChart),
+    m_chart_model(nullptr),
+    m_raster(nullptr),
     m_net_manager(nullptr),
-    m_data()
+    m_cache(),
+    m_sources(),
+    m_loading(),
+    m_series(),
+    m_pending_series(),
+    m_placeholders(),
+    m_pending_viewport(),
+    m_pending_param(),
+    m_startup_timer(),
+    m_first_frame(false),
+    m_pan_pos()
 {
+    m_startup_timer.start();
+
     m_ui->setupUi(this);
 
     _add_log_msg("Setting up");
@@ -555,16 +991,78 @@ Practice::Practice(QWidget* parent /* = nullptr */) :
 
     QObject::connect(m_ui->action_open_data, &QAction::triggered, this, &Practice::_on_action_open_data);
     QObject::connect(m_ui->action_download_data, &QAction::triggered, this, &Practice::_on_action_download_data);
+    QObject::connect(m_ui->action_memory_budget, &QAction::triggered, this, &Practice::_on_action_memory_budget);
+    QObject::connect(m_ui->action_memory_stats, &QAction::triggered, this, &Practice::_on_action_memory_stats);
 
-    QObject::connect(m_ui->clear_button, &QPushButton::pressed, [this]() { m_chart->removeAllSeries(); m_chart->setTitle(""); });
+    QObject::connect(m_ui->clear_button, &QPushButton::pressed, this, &Practice::_on_clear);
     QObject::connect(m_ui->add_series_button, &QPushButton::pressed, this, &Practice::_update);
 
     using pfunc_t = void(QComboBox::*)(const QString&);
-    QObject::connect(m_ui->combo_source, pfunc_t{ &QComboBox::activated }, [this]() { _update_combo_params(m_ui->combo_source->currentText()); });
+    QObject::connect(m_ui->combo_source, pfunc_t{ &QComboBox::activated }, [this]()
+        {
+            QString uName = m_ui->combo_source->currentText();
+            if (m_cache.contains(uName))
+            {
+                _update_combo_params(uName);
+                _show_memory_usage();
+            }
+            else
+            {
+                m_ui->combo_params->clear();
+
+                _load_source_async(uName);
+            }
+        });
+
+    _restore_session();
+
+    installEventFilter(this);
 
     _add_log_msg("Setup finished");
 }
 
+bool Practice::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == this && event->type() == QEvent::Paint && !m_first_frame)
+    {
+        m_first_frame = true;
+
+        // Let the frame finish before loading anything
+        QTimer::singleShot(0, this, &Practice::_on_first_frame);
+    }
+    else if (watched == m_ui->graphic->viewport())
+    {
+        static constexpr qreal ZOOM_FACTOR{ 1.25 };
+
+        if (auto mouse = dynamic_cast<QMouseEvent*>(event); mouse && event->type() == QEvent::MouseButtonPress && mouse->button() == Qt::LeftButton)
+            m_pan_pos = mouse->pos();
+        else if (mouse && event->type() == QEvent::MouseMove && (mouse->buttons() & Qt::LeftButton))
+        {
+            auto delta = mouse->pos() - m_pan_pos;
+            m_chart->scroll(-delta.x(), delta.y());
+
+            m_pan_pos = mouse->pos();
+
+            return true;
+        }
+        else if (auto wheel = dynamic_cast<QWheelEvent*>(event); wheel && wheel->angleDelta().y())
+        {
+            m_chart->zoom(wheel->angleDelta().y() > 0 ? ZOOM_FACTOR : 1. / ZOOM_FACTOR);
+
+            return true;
+        }
+    }
+
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void Practice::closeEvent(QCloseEvent* event)
+{
+    _save_session();
+
+    QMainWindow::closeEvent(event);
+}
+
 Practice::~Practice() noexcept
 {
     m_chart->removeAllSeries();
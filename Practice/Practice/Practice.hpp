@@ -4,27 +4,52 @@
 #include <QtCharts/QChart>
 #include <QtCharts/QLineSeries>
 #include <QNetworkAccessManager>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
 
 #include <vector>
 #include <map>
+#include <set>
+#include <optional>
 
 #include "ui_Practice.h"
+#include "DataCache.hpp"
+#include "ChartModel.hpp"
+#include "RasterLayer.hpp"
 
 class Practice : public QMainWindow
 {
     Q_OBJECT
 
+public:
+    using source_t = std::pair<QString, std::vector<QStringList>>; // uName, [params_names, dates, values...]
+    using converted_t = std::map<std::pair<QString, int>, std::vector<std::pair<qreal, qreal>>>; // (param, avg_idx) -> points
+    using loaded_t = std::pair<source_t, converted_t>;
+
 private:
-    void _csv2chart(const QString& csvstr);
-    void _json2chart(const QString& jsonstr);
+    struct series_t
+    {
+        QString uName;
+        QString param;
+        int     avg_idx;
+        int     graph_type;
+    };
+
+    void _add_source(source_t&& source, const QString& filepath, const bool select = true);
+    void _load_source_async(const QString& uName);
+    void _draw_pending(const QString& uName, const converted_t& converted = {});
 
     [[nodiscard]]
-    auto _get_converted(const size_t val_idx) const;
+    auto _get_converted(const QString& uName, const size_t val_idx, const int avg_idx) const;
 
     template<typename _SeriesType>
     void _draw_series(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values) const;
 
-    void _draw(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values) const;
+    void _draw_raster(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values, const RasterLayer::kind_t kind) const;
+
+    void _draw(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values, const int graph_type) const;
+    void _add_series(const series_t& series);
+    void _add_series(const series_t& series, const std::vector<std::pair<qreal, qreal>>& values);
 
     void _show_warning(const std::string_view msg) const;
 
@@ -35,13 +60,30 @@ private:
 
     void _setup_chart();
 
+    [[nodiscard]]
+    QString _memory_usage(const QString& uName) const;
+
+    void _log_memory_usage(const QString& uName) const;
+    void _show_memory_usage() const;
+
+    void _save_session() const;
+    void _restore_session();
+
     __forceinline void _add_log_msg(const QString& msg) const { m_ui->pte_log->appendPlainText(msg); }
     
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    void closeEvent(QCloseEvent* event) override;
+
 private slots:
     void _on_net_result(QNetworkReply* reply);
+    void _on_first_frame();
+    void _on_clear();
 
     void _on_action_open_data();
     void _on_action_download_data();
+    void _on_action_memory_budget();
+    void _on_action_memory_stats();
 
 public:
     Practice(QWidget* parent = nullptr);
@@ -50,53 +92,56 @@ public:
 private:
     mutable Ui::PracticeClass                   *m_ui;
     QtCharts::QChart                            *m_chart;
+    ChartModel                                  *m_chart_model;
+    RasterLayer                                 *m_raster;
     QNetworkAccessManager                       *m_net_manager;
-    std::map<QString, std::vector<QStringList>>  m_data; // source(kinda device) -> [params_names, dates, values...]
+    mutable DataCache                            m_cache; // source(kinda device) -> [params_names, dates, values...]
+    std::map<QString, QString>                   m_sources; // source -> file it is (re)loaded from
+    std::set<QString>                            m_loading;
+    std::vector<series_t>                        m_series;
+    std::vector<series_t>                        m_pending_series; // restored, waiting for their source
+    std::vector<std::pair<QString, QtCharts::QLineSeries*>> m_placeholders;
+    std::optional<QVariantMap>                   m_pending_viewport;
+    QString                                      m_pending_param;
+    QElapsedTimer                                m_startup_timer;
+    bool                                         m_first_frame;
+    QPoint                                       m_pan_pos;
 };
 
 template<typename _SeriesType>
 inline void Practice::_draw_series(const QString& param_name, const std::vector<std::pair<qreal, qreal>>& values) const
 {
+    static_assert(std::is_base_of_v<QtCharts::QXYSeries, _SeriesType>, "scatter and columnar modes are drawn by RasterLayer");
+
     _add_log_msg("Drawing");
 
     m_ui->label_status->setText("Preparing data for drawing");
 
-    auto bar = new QtCharts::QBarSet("");
     auto series = new _SeriesType;
     series->setUseOpenGL(true);
     series->setName(param_name);
+
+    QVector<QPointF> points;
+    points.reserve(static_cast<int>(values.size()));
+
+    auto range_x = ChartModel::EMPTY_RANGE;
+    auto range_y = ChartModel::EMPTY_RANGE;
     for (size_t i{}; i < values.size(); ++i)
     {
         auto&& [x, y] = values[i];
 
-        if constexpr (std::is_same_v<_SeriesType, QtCharts::QBarSeries>)
-            *bar << y;
-        else if constexpr (std::is_base_of_v<QtCharts::QXYSeries, _SeriesType>)
-            series->append(x, y);
+        points.push_back({ x, y });
 
-        m_ui->progress_bar->setValue((i + 1LLU) * 1. / values.size() * 100.);
-    }
+        ChartModel::extend(range_x, x);
+        ChartModel::extend(range_y, y);
 
-    if constexpr (std::is_same_v<QtCharts::QScatterSeries, _SeriesType>)
-    {
-        series->setMarkerSize(5.);
-        delete bar;
+        m_ui->progress_bar->setValue((i + 1LLU) * 1. / values.size() * 100.);
     }
-    else if constexpr (std::is_same_v<_SeriesType, QtCharts::QBarSeries>)
-        series->append(bar);
 
-    m_chart->addSeries(series);   
-    m_chart->createDefaultAxes();
-    if constexpr (std::is_base_of_v<QtCharts::QXYSeries, _SeriesType>)
-    {
-        dynamic_cast<QtCharts::QValueAxis*>(m_chart->axisX())->setTickCount(std::max_element(values.begin(), values.end(),
-            [](const auto& a, const auto& b) { return a.first < b.first; })->first + 1);
+    series->replace(points); // one update instead of one per point
 
-        dynamic_cast<QtCharts::QValueAxis*>(m_chart->axisX())->setLabelFormat("%d");
-    }
-  
-    series->attachAxis(m_chart->axisX());
-    series->attachAxis(m_chart->axisY());
+    m_chart->addSeries(series);
+    m_chart_model->add_series(series, param_name, range_x, range_y);
 
     m_ui->label_status->setText("OK");
 }
\ No newline at end of file
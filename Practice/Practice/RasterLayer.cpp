@@ -0,0 +1,368 @@
+#include "RasterLayer.hpp"
+
+#include <QPainter>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <limits>
+
+namespace detail
+{
+    static constexpr qreal MARKER_RADIUS{ 2.5 };
+    static constexpr size_t CANCEL_CHECK_STEP{ 1 << 16 }; // points between checks for a stale job
+
+    struct job_t
+    {
+        const std::atomic<size_t> &epoch;
+        size_t                     token;
+
+        [[nodiscard]] inline bool stale() const noexcept { return epoch.load(std::memory_order_relaxed) != token; }
+    };
+
+    // Scales are compared relatively and offsets up to 1/16 px, so rounding errors of QChart::scroll do not change the level
+    void append_scale(QByteArray& level, const qreal val)
+    {
+        int exp{};
+        const qint64 mantissa = std::llround(std::frexp(val, &exp) * (1LL << 40));
+
+        level.append(reinterpret_cast<const char*>(&mantissa), sizeof(mantissa));
+        level.append(reinterpret_cast<const char*>(&exp), sizeof(exp));
+    }
+
+    void append_offset(QByteArray& level, const qreal val)
+    {
+        const qint64 quantized = std::llround(val * 16.);
+
+        level.append(reinterpret_cast<const char*>(&quantized), sizeof(quantized));
+    }
+
+    [[nodiscard]]
+    bool render_scatter(QPainter& painter, const RasterLayer::layer_t& layer, const RasterLayer::points_t::const_iterator first, const RasterLayer::points_t::const_iterator last,
+        const qreal scale_x, const QPointF& origin, const job_t& job)
+    {
+        static constexpr int SIZE{ RasterLayer::TILE_SIZE };
+
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(layer.color);
+        painter.setRenderHint(QPainter::Antialiasing);
+
+        // Dense points fall into already drawn pixels, one marker per pixel is enough
+        std::bitset<SIZE * SIZE> occupied;
+
+        size_t n{};
+        for (auto it = first; it != last; ++it)
+        {
+            if (++n % CANCEL_CHECK_STEP == 0 && job.stale())
+                return false;
+
+            const QPointF pos{ it->x() * scale_x - origin.x(), layer.offset_y - it->y() * layer.scale_y - origin.y() };
+            if (pos.y() < -MARKER_RADIUS || pos.y() > SIZE + MARKER_RADIUS)
+                continue;
+
+            // Markers centered in the margin around the tile are not tracked, there are few of them
+            const int cx = static_cast<int>(std::floor(pos.x()));
+            const int cy = static_cast<int>(std::floor(pos.y()));
+            if (cx >= 0 && cx < SIZE && cy >= 0 && cy < SIZE)
+            {
+                if (occupied.test(cy * SIZE + cx))
+                    continue;
+
+                occupied.set(cy * SIZE + cx);
+            }
+
+            painter.drawEllipse(pos, MARKER_RADIUS, MARKER_RADIUS);
+        }
+
+        return true;
+    }
+
+    [[nodiscard]]
+    bool render_bars(QPainter& painter, const RasterLayer::layer_t& layer, const RasterLayer::points_t::const_iterator first, const RasterLayer::points_t::const_iterator last,
+        const qreal scale_x, const QPointF& origin, const job_t& job)
+    {
+        const qreal base = layer.offset_y - origin.y();
+        size_t n{};
+        if (layer.bar_width > 2.)
+        {
+            for (auto it = first; it != last; ++it)
+            {
+                if (++n % CANCEL_CHECK_STEP == 0 && job.stale())
+                    return false;
+
+                const qreal x = it->x() * scale_x - origin.x();
+                const qreal y = layer.offset_y - it->y() * layer.scale_y - origin.y();
+
+                painter.fillRect(QRectF(x - layer.bar_width / 2., std::min(y, base), layer.bar_width, std::abs(y - base)), layer.color);
+            }
+
+            return true;
+        }
+
+        // Thinner than a couple of pixels: one line per pixel column from the base to the extremes
+        int column{ std::numeric_limits<int>::min() };
+        qreal lo{}, hi{};
+        const auto flush = [&]()
+        {
+            if (column != std::numeric_limits<int>::min())
+                painter.fillRect(QRectF(column, std::min(lo, base), 1., std::max(hi, base) - std::min(lo, base)), layer.color);
+        };
+
+        for (auto it = first; it != last; ++it)
+        {
+            if (++n % CANCEL_CHECK_STEP == 0 && job.stale())
+                return false;
+
+            const qreal x = it->x() * scale_x - origin.x();
+            const qreal y = layer.offset_y - it->y() * layer.scale_y - origin.y();
+
+            if (const int cur = static_cast<int>(std::floor(x)); cur != column)
+            {
+                flush();
+
+                column = cur;
+                lo = hi = y;
+            }
+            else
+                lo = std::min(lo, y), hi = std::max(hi, y);
+        }
+
+        flush();
+
+        return true;
+    }
+
+    // Null image if the job became stale
+    [[nodiscard]]
+    QImage render_tile(const RasterLayer::frame_t& frame, const qint64 ix, const qint64 iy, const job_t& job)
+    {
+        if (job.stale())
+            return {};
+
+        QImage image(RasterLayer::TILE_SIZE, RasterLayer::TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+
+        const QPointF origin(static_cast<qreal>(ix) * RasterLayer::TILE_SIZE, static_cast<qreal>(iy) * RasterLayer::TILE_SIZE);
+        for (const auto& layer : frame.layers)
+        {
+            const qreal margin = layer.kind == RasterLayer::kind_t::BARS ? layer.bar_width / 2. + 1. : MARKER_RADIUS + 1.;
+            const qreal from = (origin.x() - margin) / frame.scale_x;
+            const qreal to = (origin.x() + RasterLayer::TILE_SIZE + margin) / frame.scale_x;
+
+            const auto& points = *layer.points;
+            const auto first = std::lower_bound(points.begin(), points.end(), from, [](const QPointF& p, const qreal x) { return p.x() < x; });
+            const auto last = std::upper_bound(first, points.end(), to, [](const qreal x, const QPointF& p) { return x < p.x(); });
+
+            const bool done = layer.kind == RasterLayer::kind_t::BARS
+                ? render_bars(painter, layer, first, last, frame.scale_x, origin, job)
+                : render_scatter(painter, layer, first, last, frame.scale_x, origin, job);
+            if (!done || job.stale())
+                return {};
+        }
+
+        return image;
+    }
+} // namespace detail
+
+[[nodiscard]]
+qreal RasterLayer::bar_width(const points_t& points)
+{
+    static constexpr qreal FILL{ .8 };
+
+    qreal res{ std::numeric_limits<qreal>::max() };
+    for (size_t i{ 1 }; i < points.size(); ++i)
+        if (const qreal dx = points[i].x() - points[i - 1].x(); dx > 0.)
+            res = std::min(res, dx);
+
+    return res == std::numeric_limits<qreal>::max() ? 1. : res * FILL;
+}
+
+[[nodiscard]]
+std::shared_ptr<const RasterLayer::frame_t> RasterLayer::_make_frame() const
+{
+    const auto plot = m_chart->plotArea();
+    const auto axis_x = m_model->axis_x();
+    if (m_series.empty() || plot.isEmpty() || axis_x->max() <= axis_x->min())
+        return nullptr;
+
+    auto frame = std::make_shared<frame_t>();
+    frame->scale_x = plot.width() / (axis_x->max() - axis_x->min());
+    frame->left = axis_x->min() * frame->scale_x;
+
+    frame->level.append(reinterpret_cast<const char*>(&m_generation), sizeof(m_generation));
+    detail::append_scale(frame->level, frame->scale_x);
+
+    bool first{ true };
+    for (size_t i{}; i < m_series.size(); ++i)
+    {
+        const auto& series = m_series[i];
+        if (!series.proxy->isVisible() || series.axis_y->max() <= series.axis_y->min())
+            continue;
+
+        const qreal scale_y = plot.height() / (series.axis_y->max() - series.axis_y->min());
+        const qreal top = -series.axis_y->max() * scale_y;
+
+        // Y axes are scrolled together, so their offsets relative to the first one do not change on pan
+        if (first)
+        {
+            frame->top = top;
+            first = false;
+        }
+
+        const qreal offset_y = frame->top - top;
+        frame->layers.push_back({ series.points, series.kind, series.proxy->property("color").value<QColor>(), scale_y, offset_y, series.bar_width * frame->scale_x });
+
+        // Which series are drawn is part of the level too, otherwise hiding one from the legend reuses stale tiles
+        frame->level.append(reinterpret_cast<const char*>(&i), sizeof(i));
+        detail::append_scale(frame->level, scale_y);
+        detail::append_offset(frame->level, offset_y);
+    }
+
+    if (frame->layers.empty())
+        return nullptr;
+
+    return frame;
+}
+
+void RasterLayer::_schedule(const tile_key_t& key, const std::shared_ptr<const frame_t>& frame)
+{
+    m_pending.insert(key);
+
+    auto watcher = new QFutureWatcher<QImage>(this);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, [this, watcher, key, generation = m_generation]()
+        {
+            m_pending.remove(key);
+
+            if (auto result = watcher->result(); generation == m_generation && !result.isNull())
+            {
+                const auto cost = static_cast<int>(result.sizeInBytes());
+
+                m_tiles.insert(key, new QImage(std::move(result)), cost);
+            }
+
+            // Also after a dropped job, its tile may be visible again
+            update();
+
+            watcher->deleteLater();
+        });
+
+    watcher->setFuture(QtConcurrent::run([frame, ix = key.ix, iy = key.iy, epoch = m_epoch, token = m_epoch->load()]()
+        {
+            return detail::render_tile(*frame, ix, iy, { *epoch, token });
+        }));
+}
+
+void RasterLayer::_invalidate()
+{
+    m_generation++;
+    m_tiles.clear();
+    m_epoch->fetch_add(1);
+
+    update();
+}
+
+void RasterLayer::_on_viewport_changed()
+{
+    prepareGeometryChange();
+
+    update();
+}
+
+void RasterLayer::_on_series_removed(QObject* proxy)
+{
+    auto it = std::remove_if(m_series.begin(), m_series.end(), [proxy](const auto& series) { return series.proxy == proxy; });
+    if (it == m_series.end())
+        return;
+
+    m_series.erase(it, m_series.end());
+
+    _invalidate();
+}
+
+RasterLayer::RasterLayer(QtCharts::QChart* chart, ChartModel* model) :
+    QGraphicsObject(chart),
+    m_chart(chart),
+    m_model(model),
+    m_series(),
+    m_tiles(CACHE_SIZE),
+    m_pending(),
+    m_generation(),
+    m_level(),
+    m_epoch(std::make_shared<std::atomic<size_t>>())
+{
+    setZValue(4.5); // QtCharts draws series at 4 and the legend at 5
+
+    QObject::connect(m_model, &ChartModel::viewport_changed, this, &RasterLayer::_on_viewport_changed);
+    QObject::connect(m_model, &ChartModel::series_removed, this, &RasterLayer::_on_series_removed);
+}
+
+RasterLayer::~RasterLayer() noexcept
+{
+    m_epoch->fetch_add(1); // queued tiles are not needed anymore
+}
+
+void RasterLayer::add_series(QtCharts::QAbstractSeries* proxy, QtCharts::QValueAxis* axis_y, const kind_t kind, std::shared_ptr<points_t> points)
+{
+    if (!std::is_sorted(points->begin(), points->end(), [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); }))
+        std::sort(points->begin(), points->end(), [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); });
+
+    const qreal width = kind == kind_t::BARS ? bar_width(*points) : 0.;
+
+    m_series.push_back({ proxy, axis_y, kind, std::move(points), width });
+
+    QObject::connect(proxy, &QObject::destroyed, this, &RasterLayer::_on_series_removed);
+    QObject::connect(proxy, &QtCharts::QAbstractSeries::visibleChanged, this, &RasterLayer::_on_viewport_changed);
+
+    _invalidate();
+}
+
+void RasterLayer::clear()
+{
+    for (const auto& series : m_series)
+        QObject::disconnect(series.proxy, nullptr, this, nullptr);
+
+    m_series.clear();
+
+    _invalidate();
+}
+
+[[nodiscard]]
+QRectF RasterLayer::boundingRect() const
+{
+    return m_chart->plotArea();
+}
+
+void RasterLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* /* option */, QWidget* /* widget */)
+{
+    const auto frame = _make_frame();
+    if (!frame)
+        return;
+
+    // Zoomed or resized: whatever is still queued for the old level is useless
+    if (frame->level != m_level)
+    {
+        m_level = frame->level;
+        m_epoch->fetch_add(1);
+    }
+
+    const auto plot = m_chart->plotArea();
+    painter->setClipRect(plot);
+
+    const auto first_ix = static_cast<qint64>(std::floor(frame->left / TILE_SIZE));
+    const auto last_ix = static_cast<qint64>(std::floor((frame->left + plot.width()) / TILE_SIZE));
+    const auto first_iy = static_cast<qint64>(std::floor(frame->top / TILE_SIZE));
+    const auto last_iy = static_cast<qint64>(std::floor((frame->top + plot.height()) / TILE_SIZE));
+    for (auto iy = first_iy; iy <= last_iy; ++iy)
+        for (auto ix = first_ix; ix <= last_ix; ++ix)
+        {
+            const tile_key_t key{ frame->level, ix, iy };
+            if (auto image = m_tiles.object(key))
+                painter->drawImage(QPointF(plot.left() + ix * TILE_SIZE - frame->left, plot.top() + iy * TILE_SIZE - frame->top), *image);
+            else if (!m_pending.contains(key))
+                _schedule(key, frame);
+        }
+}
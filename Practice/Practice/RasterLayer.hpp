@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QGraphicsObject>
+#include <QCache>
+#include <QSet>
+#include <QImage>
+#include <QtCharts/QChart>
+#include <QtCharts/QValueAxis>
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "ChartModel.hpp"
+
+// Draws scatter and columnar series into cached off-screen tiles instead of one graphics item per point.
+// Tiles are keyed by zoom level and position in pixel space, so panning only renders the uncovered tiles.
+// Rasterization runs on the global thread pool, jobs left over from a previous zoom level are dropped.
+class RasterLayer : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int TILE_SIZE{ 256 };
+    static constexpr int CACHE_SIZE{ 64 * 1024 * 1024 }; // bytes of tiles
+
+    enum class kind_t
+    {
+        SCATTER,
+        BARS
+    };
+
+    using points_t = std::vector<QPointF>; // sorted by x
+
+    struct tile_key_t
+    {
+        QByteArray level;
+        qint64     ix;
+        qint64     iy;
+
+        [[nodiscard]] inline bool operator==(const tile_key_t& other) const noexcept { return ix == other.ix && iy == other.iy && level == other.level; }
+    };
+
+    struct layer_t
+    {
+        std::shared_ptr<const points_t> points;
+        kind_t                          kind;
+        QColor                          color;
+        qreal                           scale_y;
+        qreal                           offset_y; // tile space y = offset_y - y * scale_y
+        qreal                           bar_width; // px
+    };
+
+    struct frame_t
+    {
+        QByteArray           level;
+        qreal                scale_x;
+        qreal                left; // viewport in tile space
+        qreal                top;
+        std::vector<layer_t> layers;
+    };
+
+    [[nodiscard]]
+    static qreal bar_width(const points_t& points);
+
+private:
+    struct series_info_t
+    {
+        QtCharts::QAbstractSeries       *proxy;
+        QtCharts::QValueAxis            *axis_y;
+        kind_t                           kind;
+        std::shared_ptr<const points_t>  points;
+        qreal                            bar_width;
+    };
+
+    [[nodiscard]]
+    std::shared_ptr<const frame_t> _make_frame() const;
+
+    void _schedule(const tile_key_t& key, const std::shared_ptr<const frame_t>& frame);
+    void _invalidate();
+
+private slots:
+    void _on_viewport_changed();
+    void _on_series_removed(QObject* proxy);
+
+public:
+    RasterLayer(QtCharts::QChart* chart, ChartModel* model);
+    ~RasterLayer() noexcept;
+
+    // proxy is an empty series that provides the legend entry, color and axes
+    void add_series(QtCharts::QAbstractSeries* proxy, QtCharts::QValueAxis* axis_y, const kind_t kind, std::shared_ptr<points_t> points);
+    void clear();
+
+    [[nodiscard]]
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+private:
+    QtCharts::QChart            *m_chart;
+    ChartModel                  *m_model;
+    std::vector<series_info_t>   m_series;
+    QCache<tile_key_t, QImage>   m_tiles;
+    QSet<tile_key_t>             m_pending;
+    size_t                       m_generation;
+    QByteArray                   m_level; // of the last painted frame
+    std::shared_ptr<std::atomic<size_t>> m_epoch; // changes with the level, checked by workers
+};
+
+[[nodiscard]]
+inline uint qHash(const RasterLayer::tile_key_t& key, const uint seed = 0) noexcept
+{
+    return qHash(key.level, seed) ^ qHash(key.ix, seed) ^ (qHash(key.iy, seed) << 1);
+}
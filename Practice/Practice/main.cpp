@@ -4,6 +4,8 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    QApplication::setOrganizationName("MyLibh");
+    QApplication::setApplicationName("Practice");
     
     Practice p;
     p.show();